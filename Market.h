@@ -6,6 +6,9 @@
 #include <queue>
 #include <iostream>
 #include <sstream>
+#include <string>
+#include <climits>
+#include <algorithm>
 
 
 // ----------------------------------------------------------------------- //
@@ -26,7 +29,7 @@ struct Trader {
     // Functions to update trader's stats
     void bought(uint32_t quantity, uint32_t price) {
         totalBought += quantity;
-        netTransfer -= static_cast<long long>(quantity * price);
+        netTransfer -= static_cast<long long>(quantity) * price;
     }
 
     void sold(uint32_t quantity, uint32_t price) {
@@ -93,6 +96,8 @@ class MedianPriorityQueue {
     public:
         void insert(uint32_t num);
         uint32_t getMedian();
+        void save(std::ostream &os) const; // used by TL index checkpoints
+        void load(std::istream &is, size_t maxValues);
 };
 
 // ----------------------------------------------------------------------- //
@@ -103,7 +108,10 @@ class Market {
 public:
     Market(uint32_t numStocks_in, uint32_t numTraders_in, bool v, bool m, bool tI, bool tT); // x
     void process_input_PR(std::stringstream &ss); // x
-    void process_input_TL(); // x
+    void process_input_TL(std::istream &is = std::cin); // x
+    void buildIndexTL(std::istream &is, std::ostream &indexOut, uint32_t interval);
+    void replayWindowTL(std::istream &is, std::istream &indexIn, uint32_t start, uint32_t end);
+    void setReplayWindow(uint32_t start, uint32_t end);
     void printEndOfDaySummary(); // x
     void printTraderInfo(); // x
     void printTimeTravelerInfo(); // x
@@ -122,6 +130,24 @@ private:
     uint32_t tradesCompleted;
     uint32_t arrivalCounter; // For tie-breaking based on arrival order
 
+    // replay window - output is only printed for timestamps in [replayStart, replayEnd]
+    // and reading stops at the first order past replayEnd
+    uint32_t replayStart = 0;
+    uint32_t replayEnd = UINT32_MAX;
+    bool silent = false; // index pass - keep all state but print nothing
+
+    // TL index - when indexOut is set, a checkpoint may be written at the first order
+    // of every nextCheckpoint boundary (multiples of indexInterval), but only once the
+    // input read since lastCheckpoint is at least as big as the checkpoint itself
+    std::ostream *indexOut = nullptr;
+    uint32_t indexInterval = 0;
+    uint64_t nextCheckpoint = 0;
+    long long lastCheckpoint = -1;
+    long long bytesPerOrder = 10; // learned from the last checkpoint written
+    static const uint64_t HASH_SEED = 1469598103934665603ULL; // FNV-1a offset basis
+    uint64_t prefixHash = HASH_SEED; // hash of input bytes [0, hashedTo), stored with each checkpoint
+    long long hashedTo = 0;
+
     // Data structures
     std::vector<time_traveler> time_traveler_tracker;
     std::vector<Trader> traders;
@@ -134,6 +160,13 @@ private:
     void matchOrders(uint32_t stockID); // x
     void outputMedianPrices(uint32_t time); // x
     void updateTimeTravelers(const Order& order, uint32_t counter); // x
+    void saveCheckpoint(std::ostream &os); // x
+    void loadCheckpoint(std::istream &is); // x
+    void writeCheckpoint(std::istream &is, long long offset, uint32_t timestamp, const char *buySell, uint32_t traderID,
+                         uint32_t stockID, uint32_t price, uint32_t quantity); // x
+    size_t restingOrders(); // x
+    static long long inputSize(std::istream &is); // x
+    static uint64_t hashInput(std::istream &is, long long from, long long to, uint64_t hash); // x
 
 };
     
@@ -161,7 +194,7 @@ Market::Market(uint32_t numStocks_in, uint32_t numTraders_in, bool v, bool m, bo
 
 } // Market ctor
 
-void Market::process_input_TL() {
+void Market::process_input_TL(std::istream &is) {
     // std::cout << "in p_i\n";
     uint32_t timestamp = 0;
     char buySell[5];
@@ -172,9 +205,16 @@ void Market::process_input_TL() {
     uint32_t quantity = 0;
 
     // std::cout << "about to start looping\n";
-    while (std::cin >> timestamp) { // time stamp auto read by while loop
+    while (is >> timestamp) { // time stamp auto read by while loop
+        if (timestamp > replayEnd) break; // past our window, treat as end of input
+
+        // at an index boundary, step back over the digits we just read so a replay lands on this order
+        long long linePos = -1;
+        if (indexOut && timestamp >= nextCheckpoint) {
+            linePos = static_cast<long long>(is.tellg()) - static_cast<long long>(std::to_string(timestamp).size());
+        }
 
-        std::cin >> buySell >> aux >> traderID >> aux 
+        is >> buySell >> aux >> traderID >> aux 
             >> stockID >> aux >> price >> aux >> quantity; // check that read works!!
 
         // for debug read in test
@@ -203,6 +243,12 @@ void Market::process_input_TL() {
             exit(1);
         }
 
+        // Checkpoint the state from BEFORE this order, so replay can seek to linePos
+        if (linePos >= 0) {
+            writeCheckpoint(is, linePos, timestamp, buySell, traderID, stockID, price, quantity);
+            nextCheckpoint = (static_cast<uint64_t>(timestamp) / indexInterval + 1) * indexInterval;
+        }
+
         // Handle timestamp change
         if (timestamp != currentTime) {
             if (median) outputMedianPrices(currentTime); // call Median at each time change
@@ -235,6 +281,139 @@ void Market::process_input_TL() {
     if (median) outputMedianPrices(currentTime);
 } // process_input_TL
 
+// Silent full pass over TL input. `interval` is the MINIMUM spacing between checkpoints
+// in timestamps: a boundary is skipped when the checkpoint would be bigger than the input
+// read since the last one, so a replay may start well before --start on big books.
+// Build with median, trader info and time travelers all on so any replay can use it
+void Market::buildIndexTL(std::istream &is, std::ostream &out, uint32_t interval) {
+    if (interval == 0) {
+        std::cerr << "Error: Index interval must be positive.\n";
+        exit(1);
+    }
+    if (is.tellg() == std::streampos(-1)) {
+        std::cerr << "Error: Input must be a seekable file to build an index.\n";
+        exit(1);
+    }
+
+    out << "TLINDEX " << numStocks << " " << numTraders << " " << interval << " " << inputSize(is) << "\n";
+    indexOut = &out;
+    indexInterval = interval;
+    nextCheckpoint = 0;
+    lastCheckpoint = -1;
+    bytesPerOrder = 10;
+    prefixHash = HASH_SEED;
+    hashedTo = 0;
+    silent = true; // nothing printed while indexing
+
+    process_input_TL(is);
+    indexOut = nullptr;
+    silent = false;
+} // buildIndexTL
+
+// Replays [start, end] by seeking to the last checkpoint at or before start.
+// Output matches a full replay of the input cut off after end, minus lines before start
+void Market::replayWindowTL(std::istream &is, std::istream &indexIn, uint32_t start, uint32_t end) {
+    if (is.tellg() == std::streampos(-1)) {
+        std::cerr << "Error: Input must be a seekable file to replay from an index.\n";
+        exit(1);
+    }
+
+    std::string tag = "";
+    uint32_t stocks = 0;
+    uint32_t tradersIn = 0;
+    uint32_t interval = 0;
+    long long size = -1;
+    indexIn >> tag >> stocks >> tradersIn >> interval >> size;
+    if (tag != "TLINDEX" || stocks != numStocks || tradersIn != numTraders || size != inputSize(is)) {
+        std::cerr << "Error: Index does not match input.\n";
+        exit(1);
+    }
+
+    // checkpoints are in timestamp order, only parse the header of each until we pass start
+    long long seekTo = -1;
+    std::streampos bestBody = 0;
+    uint32_t cpTime = 0;
+    long long offset = 0;
+    long long length = 0;
+    uint64_t hash = 0, bestHash = 0;
+    uint32_t bestTime = 0;
+    std::string order = "", bestOrder = ""; // first order at the checkpoint, checked after seeking
+    while (indexIn >> tag >> cpTime >> offset >> length >> hash && tag == "CHECKPOINT"
+            && std::getline(indexIn, order)) {
+        if (cpTime > start) break;
+        seekTo = offset;
+        bestHash = hash;
+        bestTime = cpTime;
+        bestOrder = order;
+        bestBody = indexIn.tellg();
+        indexIn.seekg(length, std::ios_base::cur);
+    }
+
+    setReplayWindow(start, end);
+    if (seekTo >= 0) {
+        // everything we skip must be byte for byte what the index was built from,
+        // raw reads are far cheaper than parsing it
+        std::streampos orderStart = is.tellg();
+        if (seekTo < orderStart || hashInput(is, 0, seekTo, HASH_SEED) != bestHash) {
+            std::cerr << "Error: Index does not match input.\n";
+            exit(1);
+        }
+
+        indexIn.clear();
+        indexIn.seekg(bestBody);
+        loadCheckpoint(indexIn);
+
+        is.clear();
+        is.seekg(seekTo);
+
+        // make sure the order we landed on is the one the index was built from
+        std::string buySell = "";
+        char aux = '\0';
+        uint32_t ts = 0, traderID = 0, stockID = 0, price = 0, quantity = 0;
+        is >> ts >> buySell >> aux >> traderID >> aux >> stockID >> aux >> price >> aux >> quantity;
+        std::ostringstream landed;
+        landed << " " << buySell[0] << " " << traderID << " " << stockID << " " << price << " " << quantity;
+        if (!is || buySell.empty() || ts != bestTime || landed.str() != bestOrder) {
+            std::cerr << "Error: Index does not match input.\n";
+            exit(1);
+        }
+        is.seekg(seekTo);
+    }
+
+    process_input_TL(is);
+} // replayWindowTL
+
+// Size of the whole input, used to tell one TL file's index from another's
+long long Market::inputSize(std::istream &is) {
+    std::streampos pos = is.tellg();
+    is.seekg(0, std::ios_base::end);
+    long long size = static_cast<long long>(is.tellg());
+    is.seekg(pos);
+    return size;
+} // inputSize
+
+// FNV-1a over input bytes [from, to), continuing from `hash` (HASH_SEED to start).
+// Leaves `is` positioned at `to`, or failed on a short read
+uint64_t Market::hashInput(std::istream &is, long long from, long long to, uint64_t hash) {
+    char buffer[1 << 16];
+    is.clear();
+    is.seekg(from);
+    while (is && from < to) {
+        std::streamsize chunk = static_cast<std::streamsize>(std::min<long long>(to - from, sizeof(buffer)));
+        if (!is.read(buffer, chunk)) break;
+        for (std::streamsize i = 0; i < chunk; i++) {
+            hash = (hash ^ static_cast<unsigned char>(buffer[i])) * 1099511628211ULL;
+        }
+        from += chunk;
+    }
+    return hash;
+} // hashInput
+
+void Market::setReplayWindow(uint32_t start, uint32_t end) {
+    replayStart = start;
+    replayEnd = end;
+} // setReplayWindow
+
 void Market::process_input_PR (std::stringstream &ss) {
     uint32_t timestamp = 0;
     std::string buySell = "";
@@ -374,7 +553,7 @@ void Market::matchOrders(uint32_t stockID) {
         }
 
         // Verbose output
-        if (verbose) {
+        if (verbose && !silent && currentTime >= replayStart) {
             std::cout << "Trader " << buyOrder.traderID << " purchased "
                       << tradeQuantity << " shares of Stock " << stockID
                       << " from Trader " << sellOrder.traderID << " for $"
@@ -396,6 +575,8 @@ void Market::matchOrders(uint32_t stockID) {
 
 // Output median prices
 void Market::outputMedianPrices(uint32_t time) {
+    if (silent || time < replayStart) return; // indexing, or outside of replay window
+
     for (uint32_t i = 0; i < numStocks; i++) {
         uint32_t value = medianPQ[i].getMedian();
 
@@ -458,9 +639,9 @@ void Market::updateTimeTravelers(const Order& order, uint32_t counter) {
         }
 
         // if in potential mode and an order comes along that can earn more than what we already have, change it to our main and put into 'c'
-        // !!!might cause issues with unsigned ints!!!
-        if (time_traveler_tracker[id].mode == 'p' && ((int)order.price - (int)time_traveler_tracker[id].potential_buy_price) 
-            > ((int)time_traveler_tracker[id].sell_price - (int)time_traveler_tracker[id].buy_price) && time_traveler_tracker[id].aT < counter) {
+        // long long so prices above INT32_MAX don't overflow the profit comparison
+        if (time_traveler_tracker[id].mode == 'p' && ((long long)order.price - (long long)time_traveler_tracker[id].potential_buy_price) 
+            > ((long long)time_traveler_tracker[id].sell_price - (long long)time_traveler_tracker[id].buy_price) && time_traveler_tracker[id].aT < counter) {
 
                 time_traveler_tracker[id].buy_price = time_traveler_tracker[id].potential_buy_price;
                 time_traveler_tracker[id].buy_time = time_traveler_tracker[id].potential_buy_time;
@@ -493,6 +674,145 @@ void Market::printTimeTravelerInfo() {
 
 } //printTTinfo
 
+// Writes every order book, median heap, trader and time traveler as plain text.
+// Empty sections are still written (size 0) so loadCheckpoint can always parse them
+void Market::saveCheckpoint(std::ostream &os) {
+    os << currentTime << " " << tradesCompleted << " " << arrivalCounter << "\n";
+
+    // copy each PQ and pop it, the order comes out in priority order
+    for (uint32_t i = 0; i < numStocks; i++) {
+        auto buyPQ = buyOrders[i];
+        os << buyPQ.size();
+        for (; !buyPQ.empty(); buyPQ.pop()) {
+            const Order &o = buyPQ.top();
+            os << " " << o.timestamp << " " << o.traderID << " " << o.price << " " << o.quantity << " " << o.orderNum;
+        }
+        auto sellPQ = sellOrders[i];
+        os << "\n" << sellPQ.size();
+        for (; !sellPQ.empty(); sellPQ.pop()) {
+            const Order &o = sellPQ.top();
+            os << " " << o.timestamp << " " << o.traderID << " " << o.price << " " << o.quantity << " " << o.orderNum;
+        }
+        os << "\n";
+    }
+
+    os << medianPQ.size() << "\n";
+    for (const MedianPriorityQueue &m : medianPQ) m.save(os);
+
+    os << traders.size() << "\n";
+    for (const Trader &t : traders) {
+        os << t.totalBought << " " << t.totalSold << " " << t.netTransfer << "\n";
+    }
+
+    os << time_traveler_tracker.size() << "\n";
+    for (const time_traveler &tt : time_traveler_tracker) {
+        os << tt.mode << " " << tt.aT << " " << tt.sell_time << " " << tt.buy_time << " " << tt.buy_price
+           << " " << tt.sell_price << " " << tt.potential_buy_price << " " << tt.potential_buy_time << "\n";
+    }
+} // saveCheckpoint
+
+// Writes the checkpoint for the order at `offset` if the input since the last one pays
+// for it, which keeps the whole index no bigger than the input (plus one header line each)
+void Market::writeCheckpoint(std::istream &is, long long offset, uint32_t timestamp, const char *buySell, uint32_t traderID,
+                             uint32_t stockID, uint32_t price, uint32_t quantity) {
+    long long budget = lastCheckpoint < 0 ? LLONG_MAX : offset - lastCheckpoint;
+    // skip copying the books when they clearly won't fit, every saved order takes at
+    // least 10 bytes ("1 1 1 1 1 ") and usually about what the last checkpoint used
+    long long resting = static_cast<long long>(restingOrders());
+    if (resting * bytesPerOrder > budget) return;
+
+    std::stringstream body;
+    saveCheckpoint(body);
+    std::string bodyStr = body.str();
+    if (static_cast<long long>(bodyStr.size()) > budget) return;
+
+    // extend the prefix hash up to this order, then go back to where parsing left off
+    std::streampos resume = is.tellg();
+    prefixHash = hashInput(is, hashedTo, offset, prefixHash);
+    if (!is) {
+        std::cerr << "Error: Could not re-read input while building the index.\n";
+        exit(1);
+    }
+    hashedTo = offset;
+    is.seekg(resume);
+
+    *indexOut << "CHECKPOINT " << timestamp << " " << offset << " " << bodyStr.size() << " " << prefixHash
+              << " " << buySell[0] << " " << traderID << " " << stockID << " " << price << " " << quantity
+              << "\n" << bodyStr;
+    lastCheckpoint = offset;
+    if (resting > 0) bytesPerOrder = std::max(10LL, static_cast<long long>(bodyStr.size()) / resting);
+} // writeCheckpoint
+
+size_t Market::restingOrders() {
+    size_t count = 0;
+    for (uint32_t i = 0; i < numStocks; i++) count += buyOrders[i].size() + sellOrders[i].size();
+    return count;
+} // restingOrders
+
+// Restores a checkpoint, only keeping the sections for the modes we're running.
+// Counts and IDs are checked against what the checkpoint itself claims, so a damaged
+// index fails the stream instead of allocating or indexing out of range
+void Market::loadCheckpoint(std::istream &is) {
+    is >> currentTime >> tradesCompleted >> arrivalCounter;
+
+    size_t count = 0;
+    for (uint32_t i = 0; i < numStocks && is; i++) {
+        for (int side = 0; side < 2; side++) {
+            bool isBuy = side == 0;
+            std::vector<Order> book;
+            if (is >> count && count > arrivalCounter) is.setstate(std::ios_base::failbit);
+            for (size_t j = 0; j < count && is; j++) {
+                uint32_t ts = 0, tID = 0, p = 0, q = 0, num = 0;
+                is >> ts >> tID >> p >> q >> num;
+                if (ts > currentTime || tID >= numTraders || p == 0 || q == 0 || num == 0 || num > arrivalCounter) {
+                    is.setstate(std::ios_base::failbit);
+                }
+                book.emplace_back(ts, tID, i, isBuy, p, q, num);
+            }
+            if (isBuy) {
+                buyOrders[i] = std::priority_queue<Order, std::vector<Order>, BuyOrderComparator>(
+                    BuyOrderComparator(), std::move(book));
+            } else {
+                sellOrders[i] = std::priority_queue<Order, std::vector<Order>, SellOrderComparator>(
+                    SellOrderComparator(), std::move(book));
+            }
+        }
+    }
+
+    // each section is either empty (mode was off when indexing) or one entry per stock/trader
+    std::vector<MedianPriorityQueue> medians;
+    if (is >> count && count != 0 && count != numStocks) is.setstate(std::ios_base::failbit);
+    if (is) medians.resize(count);
+    for (MedianPriorityQueue &m : medians) m.load(is, tradesCompleted);
+
+    std::vector<Trader> tradersIn;
+    if (is >> count && count != 0 && count != numTraders) is.setstate(std::ios_base::failbit);
+    if (is) tradersIn.resize(count);
+    for (Trader &t : tradersIn) is >> t.totalBought >> t.totalSold >> t.netTransfer;
+
+    std::vector<time_traveler> travelers;
+    if (is >> count && count != 0 && count != numStocks) is.setstate(std::ios_base::failbit);
+    if (is) travelers.resize(count);
+    for (time_traveler &tt : travelers) {
+        is >> tt.mode >> tt.aT >> tt.sell_time >> tt.buy_time >> tt.buy_price
+           >> tt.sell_price >> tt.potential_buy_price >> tt.potential_buy_time;
+        if (tt.mode != 'n' && tt.mode != 'b' && tt.mode != 'c' && tt.mode != 'p') is.setstate(std::ios_base::failbit);
+    }
+
+    if (!is) {
+        std::cerr << "Error: Index checkpoint is corrupt.\n";
+        exit(1);
+    }
+    if ((median && medians.size() != numStocks) || (traderInfo && tradersIn.size() != numTraders)
+            || (timeTravelers && travelers.size() != numStocks)) {
+        std::cerr << "Error: Index checkpoint is missing state for the requested modes.\n";
+        exit(1);
+    }
+    if (median) medianPQ = std::move(medians);
+    if (traderInfo) traders = std::move(tradersIn);
+    if (timeTravelers) time_traveler_tracker = std::move(travelers);
+} // loadCheckpoint
+
 
 
 // ----------------------------------------------------------------------- //
@@ -524,7 +844,7 @@ uint32_t MedianPriorityQueue::getMedian() {
     if (maxHeap.empty() && minHeap.empty()) return UINT32_MAX;
 
     if (maxHeap.size() == minHeap.size()) {
-        return (maxHeap.top() + minHeap.top()) / 2;
+        return static_cast<uint32_t>((static_cast<uint64_t>(maxHeap.top()) + minHeap.top()) / 2); // no wrap on huge prices
     } else if (maxHeap.size() > minHeap.size()) {
         return maxHeap.top();
     } else {
@@ -532,4 +852,50 @@ uint32_t MedianPriorityQueue::getMedian() {
     }
 } // fastMedian - getMedian
 
+// each heap is written as sorted (price, count) runs, matched prices repeat a lot
+static void saveHeapRuns(std::ostream &os, std::vector<uint32_t> &sorted) {
+    std::vector<std::pair<uint32_t, size_t>> runs;
+    for (uint32_t v : sorted) {
+        if (runs.empty() || runs.back().first != v) runs.emplace_back(v, 0);
+        runs.back().second++;
+    }
+    os << runs.size();
+    for (const auto &r : runs) os << " " << r.first << " " << r.second;
+    os << "\n";
+} // saveHeapRuns
+
+// fails the stream rather than growing past maxValues (one value per trade)
+static void loadHeapRuns(std::istream &is, std::vector<uint32_t> &values, size_t maxValues) {
+    size_t runs = 0;
+    is >> runs;
+    for (size_t i = 0; i < runs && is; i++) {
+        uint32_t v = 0;
+        size_t count = 0;
+        is >> v >> count;
+        if (count > maxValues - values.size()) {
+            is.setstate(std::ios_base::failbit);
+            return;
+        }
+        values.insert(values.end(), count, v);
+    }
+} // loadHeapRuns
+
+void MedianPriorityQueue::save(std::ostream &os) const {
+    std::vector<uint32_t> sorted;
+    for (auto low = maxHeap; !low.empty(); low.pop()) sorted.push_back(low.top());
+    saveHeapRuns(os, sorted);
+    sorted.clear();
+    for (auto high = minHeap; !high.empty(); high.pop()) sorted.push_back(high.top());
+    saveHeapRuns(os, sorted);
+} // fastMedian - save
+
+void MedianPriorityQueue::load(std::istream &is, size_t maxValues) {
+    std::vector<uint32_t> low, high;
+    loadHeapRuns(is, low, maxValues);
+    loadHeapRuns(is, high, maxValues - low.size());
+    maxHeap = std::priority_queue<uint32_t>(std::less<uint32_t>(), std::move(low));
+    minHeap = std::priority_queue<uint32_t, std::vector<uint32_t>, std::greater<uint32_t>>(
+        std::greater<uint32_t>(), std::move(high));
+} // fastMedian - load
+
 #endif // MARKET_HPP
\ No newline at end of file
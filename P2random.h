@@ -32,8 +32,8 @@ public:
         } // for
     } // PR_init()
 
-private:
     // Adapted from http://www.pcg-random.org
+    // public so test drivers can generate their own order streams
     struct Prng {
         using result_type = uint32_t;
         explicit Prng() noexcept = default;
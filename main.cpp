@@ -2,6 +2,10 @@
 #include <getopt.h>
 #include <iostream>
 #include <sstream>
+#include <fstream>
+#include <string>
+#include <cerrno>
+#include <cstdlib>
 #include "Market.h"
 #include "P2random.h" // Include the pseudorandom generator header
 
@@ -12,19 +16,43 @@
         {"median", no_argument, nullptr, 'm'},
         {"trader_info", no_argument, nullptr, 'i'},
         {"time_travelers", no_argument, nullptr, 't'},
+        {"build_index", required_argument, nullptr, 'x'},
+        {"index_interval", required_argument, nullptr, 'n'},
+        {"replay_index", required_argument, nullptr, 'r'},
+        {"start", required_argument, nullptr, 's'},
+        {"end", required_argument, nullptr, 'e'},
         {nullptr, 0, nullptr, 0}
     };
 
+// parses a whole optarg as a uint32_t, errors out on junk or out of range values
+static uint32_t parseUint32(const char *arg, const char *name) {
+    char *endPtr = nullptr;
+    errno = 0;
+    unsigned long long value = std::strtoull(arg, &endPtr, 10);
+    if (*arg == '\0' || *arg == '-' || *endPtr != '\0' || errno == ERANGE || value > UINT32_MAX) {
+        std::cerr << "Error: Invalid value for --" << name << ".\n";
+        exit(1);
+    }
+    return static_cast<uint32_t>(value);
+} // parseUint32
+
 int main(int argc, char *argv[]) {
     std::ios_base::sync_with_stdio(false);
     bool verbose = false;
     bool median = false;
     bool traderInfo = false;
     bool timeTravelers = false;
+    std::string buildIndexFile = ""; // TL only: write a seek index, no output
+    std::string replayIndexFile = ""; // TL only: seek using an index from --build_index
+    uint32_t indexInterval = 1000; // minimum timestamps between checkpoints, see buildIndexTL
+    uint32_t start = 0;
+    uint32_t end = UINT32_MAX;
+    bool intervalGiven = false;
+    bool windowGiven = false;
     int gotopt;
 
     // Parse options using getopt_long
-    while ((gotopt = getopt_long(argc, argv, "vmit", long_options, nullptr)) != -1) {
+    while ((gotopt = getopt_long(argc, argv, "vmitx:n:r:s:e:", long_options, nullptr)) != -1) {
         switch (gotopt) {
             case 'v': 
                 verbose = true; // verbose
@@ -38,12 +66,48 @@ int main(int argc, char *argv[]) {
             case 't':
                 timeTravelers = true; // time_travelers
                 break;
+            case 'x':
+                buildIndexFile = optarg; // build_index
+                break;
+            case 'n':
+                indexInterval = parseUint32(optarg, "index_interval"); // index_interval
+                intervalGiven = true;
+                break;
+            case 'r':
+                replayIndexFile = optarg; // replay_index
+                break;
+            case 's':
+                start = parseUint32(optarg, "start"); // start
+                windowGiven = true;
+                break;
+            case 'e':
+                end = parseUint32(optarg, "end"); // end
+                windowGiven = true;
+                break;
             default:
-                std::cerr << "Usage: " << argv[0] << " [-v] [-m] [-i] [-t]\n";
+                std::cerr << "Usage: " << argv[0] << " [-v] [-m] [-i] [-t] [-x index [-n interval]]"
+                          << " [-r index] [-s start] [-e end]\n"
+                          << "  -n is the minimum number of timestamps between index checkpoints (default 1000),\n"
+                          << "     boundaries are skipped while a checkpoint would outweigh the input since the last\n";
                 exit(1);
         } // switch
     } // while
 
+    if (start > end) {
+        std::cerr << "Error: Replay start is after replay end.\n";
+        exit(1);
+    }
+    // building an index prints nothing, so replay/output flags alongside it would be ignored
+    if (!buildIndexFile.empty() && (!replayIndexFile.empty() || windowGiven
+            || verbose || median || traderInfo || timeTravelers)) {
+        std::cerr << "Error: --build_index can't be combined with replay or output options.\n";
+        exit(1);
+    }
+    if (intervalGiven && buildIndexFile.empty()) {
+        std::cerr << "Error: --index_interval only applies with --build_index.\n";
+        exit(1);
+    }
+
     //  -------------------------------------------------------------- //
     //                end getopts... DRIVER CODE HERE                 //
     //  ------------------------------------------------------------ //
@@ -62,11 +126,38 @@ int main(int argc, char *argv[]) {
     std::cin >> comment >> traders >> comment >> stocks; // reads number of traders and stocks
     std::stringstream ss; // creates a stream if we have PR mode
 
+    if (in_mode != "TL" && (!buildIndexFile.empty() || !replayIndexFile.empty() || windowGiven || intervalGiven)) {
+        std::cerr << "Error: Index and replay window options only work with TL input.\n";
+        exit(1);
+    }
+
     // create an instance of Market Class, "market"
     Market market(stocks, traders, verbose, median, traderInfo, timeTravelers);
 
-    if (in_mode == "TL") { // process the rest of our cin stream
+    if (in_mode == "TL" && !buildIndexFile.empty()) { // index pass only, keeps every mode's state
+        std::ofstream indexOut(buildIndexFile);
+        if (!indexOut) {
+            std::cerr << "Error: Could not open index file.\n";
+            exit(1);
+        }
+        Market indexer(stocks, traders, false, true, true, true);
+        indexer.buildIndexTL(std::cin, indexOut, indexInterval);
+        indexOut.close();
+        if (!indexOut) { // e.g. disk full, don't leave a truncated index looking valid
+            std::cerr << "Error: Could not write index file.\n";
+            exit(1);
+        }
+        return 0;
+    } else if (in_mode == "TL" && !replayIndexFile.empty()) { // seek near start and replay [start, end]
+        std::ifstream indexIn(replayIndexFile);
+        if (!indexIn) {
+            std::cerr << "Error: Could not open index file.\n";
+            exit(1);
+        }
+        market.replayWindowTL(std::cin, indexIn, start, end);
+    } else if (in_mode == "TL") { // process the rest of our cin stream
         // ss << std::cin.rdbuf();  // Read all data from std::cin into the stringstream
+        market.setReplayWindow(start, end);
         market.process_input_TL();
     } else if (in_mode == "PR") { // proccess PR mode
         std::string aux = ""; // used as junk read for preceeding symbols & words
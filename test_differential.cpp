@@ -0,0 +1,280 @@
+// Project Identifier: 0E04A31E0D60C01986ACB20081C9D8722A1899B6
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "Market.h"
+#include "P2random.h"
+
+// Differential fuzz harness: random TL order streams are run through Market and
+// through the slow, obviously-correct reference below, and the outputs must match
+// line for line. Some streams are replayed over a [start, end] window, either straight
+// through or from an index built in memory, to cover the seek/checkpoint paths too.
+// Usage: ./test_differential [iterations] [seed]
+
+
+// ----------------------------------------------------------------------- //
+//                        Reference Implementation                        //
+// --------------------------------------------------------------------- //
+
+struct RefOrder {
+    uint32_t timestamp = 0;
+    uint32_t traderID = 0;
+    uint32_t stockID = 0;
+    bool isBuy = true;
+    uint32_t price = 0;
+    uint32_t quantity = 0;
+};
+
+struct StreamSpec {
+    uint32_t numStocks = 1;
+    uint32_t numTraders = 1;
+    bool verbose = false;
+    bool median = false;
+    bool traderInfo = false;
+    bool timeTravelers = false;
+    uint32_t start = 0; // replay window
+    uint32_t end = UINT32_MAX;
+    uint32_t indexInterval = 0; // 0 - replay without an index
+    std::vector<RefOrder> orders;
+};
+
+// linear scans over every resting order, no heaps anywhere
+std::string runReference(const StreamSpec &spec) {
+    std::ostringstream os;
+    std::vector<std::vector<size_t>> book(spec.numStocks); // indices into orders, resting only
+    std::vector<uint32_t> remaining;
+    std::vector<std::vector<uint32_t>> prices(spec.numStocks); // every match price, kept sorted
+    std::vector<uint64_t> bought(spec.numTraders), sold(spec.numTraders);
+    std::vector<long long> net(spec.numTraders);
+    uint32_t trades = 0;
+    uint32_t currentTime = 0;
+
+    auto printMedians = [&](uint32_t time) {
+        for (uint32_t s = 0; s < spec.numStocks; s++) {
+            const std::vector<uint32_t> &p = prices[s];
+            if (p.empty() || time < spec.start) continue;
+            uint64_t value = p.size() % 2 ? p[p.size() / 2]
+                : (uint64_t(p[p.size() / 2 - 1]) + p[p.size() / 2]) / 2;
+            os << "Median match price of Stock " << s << " at time " << time << " is $" << value << "\n";
+        }
+    };
+
+    for (size_t idx = 0; idx < spec.orders.size(); idx++) {
+        const RefOrder &o = spec.orders[idx];
+        if (o.timestamp > spec.end) break; // window ends here, as if the input did
+        if (o.timestamp != currentTime) {
+            if (spec.median) printMedians(currentTime);
+            currentTime = o.timestamp;
+        }
+        remaining.push_back(o.quantity);
+        book[o.stockID].push_back(idx);
+
+        while (true) {
+            // best buy: highest price, then earliest; best sell: lowest price, then earliest
+            size_t buy = SIZE_MAX, sell = SIZE_MAX;
+            for (size_t r : book[o.stockID]) {
+                const RefOrder &c = spec.orders[r];
+                if (c.isBuy && (buy == SIZE_MAX || c.price > spec.orders[buy].price)) buy = r;
+                if (!c.isBuy && (sell == SIZE_MAX || c.price < spec.orders[sell].price)) sell = r;
+            }
+            if (buy == SIZE_MAX || sell == SIZE_MAX || spec.orders[sell].price > spec.orders[buy].price) break;
+
+            // the order that was already resting sets the price
+            uint32_t price = sell < buy ? spec.orders[sell].price : spec.orders[buy].price;
+            uint32_t quantity = std::min(remaining[buy], remaining[sell]);
+            uint32_t buyer = spec.orders[buy].traderID;
+            uint32_t seller = spec.orders[sell].traderID;
+
+            trades++;
+            bought[buyer] += quantity;
+            sold[seller] += quantity;
+            net[buyer] -= static_cast<long long>(quantity) * price;
+            net[seller] += static_cast<long long>(quantity) * price;
+            prices[o.stockID].insert(std::upper_bound(prices[o.stockID].begin(),
+                prices[o.stockID].end(), price), price);
+            if (spec.verbose && o.timestamp >= spec.start) {
+                os << "Trader " << buyer << " purchased " << quantity << " shares of Stock " << o.stockID
+                   << " from Trader " << seller << " for $" << price << "/share\n";
+            }
+
+            remaining[buy] -= quantity;
+            remaining[sell] -= quantity;
+            auto &rest = book[o.stockID];
+            rest.erase(std::remove_if(rest.begin(), rest.end(),
+                [&](size_t r) { return remaining[r] == 0; }), rest.end());
+        } // while
+    } // for
+    if (spec.median) printMedians(currentTime);
+
+    os << "---End of Day---\n";
+    os << "Trades Completed: " << trades << "\n";
+
+    if (spec.traderInfo) {
+        os << "---Trader Info---\n";
+        for (uint32_t t = 0; t < spec.numTraders; t++) {
+            os << "Trader " << t << " bought " << bought[t] << " and sold " << sold[t]
+               << " for a net transfer of $" << net[t] << "\n";
+        }
+    }
+
+    // every (sell, later buy) pair inside the window - most profit, then earliest sell, then earliest buy
+    if (spec.timeTravelers) {
+        os << "---Time Travelers---\n";
+        for (uint32_t s = 0; s < spec.numStocks; s++) {
+            size_t bestSell = SIZE_MAX, bestBuy = SIZE_MAX;
+            long long bestProfit = 0;
+            for (size_t i = 0; i < spec.orders.size(); i++) {
+                const RefOrder &a = spec.orders[i];
+                if (a.timestamp > spec.end) break;
+                if (a.stockID != s || a.isBuy) continue;
+                for (size_t j = i + 1; j < spec.orders.size(); j++) {
+                    const RefOrder &b = spec.orders[j];
+                    if (b.timestamp > spec.end) break;
+                    if (b.stockID != s || !b.isBuy) continue;
+                    long long profit = static_cast<long long>(b.price) - a.price;
+                    if (profit > bestProfit) {
+                        bestProfit = profit;
+                        bestSell = i;
+                        bestBuy = j;
+                    }
+                }
+            }
+            if (bestSell == SIZE_MAX) {
+                os << "A time traveler could not make a profit on Stock " << s << "\n";
+            } else {
+                os << "A time traveler would buy Stock " << s << " at time " << spec.orders[bestSell].timestamp
+                   << " for $" << spec.orders[bestSell].price << " and sell it at time "
+                   << spec.orders[bestBuy].timestamp << " for $" << spec.orders[bestBuy].price << "\n";
+            }
+        }
+    }
+    return os.str();
+} // runReference
+
+
+// ----------------------------------------------------------------------- //
+//                       Engine, Generator & Driver                       //
+// --------------------------------------------------------------------- //
+
+std::string toTL(const StreamSpec &spec) {
+    std::ostringstream os;
+    for (const RefOrder &o : spec.orders) {
+        os << o.timestamp << (o.isBuy ? " BUY T" : " SELL T") << o.traderID << " S"
+           << o.stockID << " $" << o.price << " #" << o.quantity << "\n";
+    }
+    return os.str();
+} // toTL
+
+// runs Market in-process, capturing everything it writes to std::cout
+std::string runMarket(const StreamSpec &spec) {
+    std::istringstream in(toTL(spec));
+    std::ostringstream out;
+    std::streambuf *old = std::cout.rdbuf(out.rdbuf());
+
+    Market market(spec.numStocks, spec.numTraders, spec.verbose, spec.median,
+                  spec.traderInfo, spec.timeTravelers);
+    if (spec.indexInterval) { // same as main: index with every mode on, then seek into the window
+        std::stringstream index;
+        Market indexer(spec.numStocks, spec.numTraders, false, true, true, true);
+        indexer.buildIndexTL(in, index, spec.indexInterval);
+        in.clear();
+        in.seekg(0);
+        market.replayWindowTL(in, index, spec.start, spec.end);
+    } else {
+        market.setReplayWindow(spec.start, spec.end);
+        market.process_input_TL(in);
+    }
+    market.printEndOfDaySummary();
+    if (spec.traderInfo) market.printTraderInfo();
+    if (spec.timeTravelers) market.printTimeTravelerInfo();
+
+    std::cout.rdbuf(old);
+    return out.str();
+} // runMarket
+
+// Each stream mixes a few adversarial knobs: one price level (every order ties),
+// one timestamp (arrival order is the only tie breaker), huge quantities or huge
+// prices, and few traders so people trade with themselves
+StreamSpec generate(P2random::Prng &rng) {
+    StreamSpec spec;
+    spec.numStocks = rng() % 4 + 1;
+    spec.numTraders = rng() % 5 + 1;
+    spec.verbose = rng() % 4 != 0;
+    spec.median = rng() % 4 != 0;
+    spec.traderInfo = rng() % 4 != 0;
+    spec.timeTravelers = rng() % 4 != 0;
+
+    uint32_t numOrders = rng() % 16 == 0 ? rng() % 512 + 1 : rng() % 48 + 1;
+    bool equalPrice = rng() % 4 == 0;
+    bool equalTime = rng() % 4 == 0;
+    bool hugeQuantity = rng() % 6 == 0;
+    bool hugePrice = !hugeQuantity && rng() % 8 == 0;
+
+    // keep per-trader totals within uint32_t and net transfers within long long, prices
+    // can go all the way to UINT32_MAX so median sums and profits must not wrap
+    uint32_t maxQuantity = hugeQuantity ? UINT32_MAX / numOrders : 50;
+    uint32_t maxPrice = hugePrice ? UINT32_MAX : (hugeQuantity ? 1000 : 100);
+    uint32_t basePrice = rng() % maxPrice + 1;
+
+    uint32_t timestamp = 0;
+    for (uint32_t i = 0; i < numOrders; i++) {
+        if (!equalTime && rng() % 3 == 0) timestamp += rng() % 3 + 1;
+        RefOrder o;
+        o.timestamp = timestamp;
+        o.traderID = rng() % spec.numTraders;
+        o.stockID = rng() % spec.numStocks;
+        o.isBuy = rng() % 2 == 0;
+        o.price = equalPrice ? basePrice : rng() % maxPrice + 1;
+        o.quantity = rng() % maxQuantity + 1;
+        spec.orders.push_back(o);
+    }
+
+    // half the streams replay a window, half of those from an index
+    if (rng() % 2 == 0) {
+        spec.start = rng() % (timestamp + 2);
+        spec.end = rng() % 4 == 0 ? UINT32_MAX : spec.start + rng() % (timestamp + 2);
+        if (rng() % 2 == 0) spec.indexInterval = rng() % 4 + 1;
+    }
+    return spec;
+} // generate
+
+// prints the first line that differs plus the input so the case can be replayed
+void reportMismatch(const StreamSpec &spec, const std::string &expected, const std::string &actual,
+                    uint64_t iteration, uint32_t seed) {
+    std::istringstream e(expected), a(actual);
+    std::string eLine = "", aLine = "";
+    uint32_t lineNum = 1;
+    while (std::getline(e, eLine) && std::getline(a, aLine) && eLine == aLine) lineNum++;
+
+    std::cerr << "Mismatch at iteration " << iteration << " (seed " << seed << "), output line " << lineNum << "\n"
+              << "  reference: " << eLine << "\n"
+              << "  market:    " << aLine << "\n"
+              << "Input (flags" << (spec.verbose ? " -v" : "") << (spec.median ? " -m" : "")
+              << (spec.traderInfo ? " -i" : "") << (spec.timeTravelers ? " -t" : "")
+              << " -s " << spec.start << " -e " << spec.end;
+    if (spec.indexInterval) std::cerr << ", replayed from an index built with -n " << spec.indexInterval;
+    std::cerr << "):\n"
+              << "COMMENT: test_differential\nMODE: TL\nNUM_TRADERS: " << spec.numTraders
+              << "\nNUM_STOCKS: " << spec.numStocks << "\n" << toTL(spec);
+} // reportMismatch
+
+int main(int argc, char *argv[]) {
+    uint64_t iterations = argc > 1 ? std::stoull(argv[1]) : 100000;
+    uint32_t seed = argc > 2 ? static_cast<uint32_t>(std::stoul(argv[2])) : 281;
+    P2random::Prng rng(seed);
+
+    for (uint64_t i = 0; i < iterations; i++) {
+        StreamSpec spec = generate(rng);
+        std::string expected = runReference(spec);
+        std::string actual = runMarket(spec);
+        if (expected != actual) {
+            reportMismatch(spec, expected, actual, i, seed);
+            return 1;
+        }
+        if ((i + 1) % 100000 == 0) std::cout << (i + 1) << " streams matched\n" << std::flush;
+    }
+    std::cout << "All " << iterations << " streams matched\n";
+    return 0;
+} // main